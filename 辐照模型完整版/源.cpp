@@ -16,6 +16,10 @@ using namespace std;
 using namespace glm;
 
 const GLuint screenWidth = 1024, screenHeight = 720;
+//ֱ̬:ȾŵԼÿ֡GPUʱԤ()
+const GLfloat minRenderScale = 0.5f, maxRenderScale = 1.0f;
+const GLfloat targetFrameTime = 16.6f;
+const GLuint msaaSamples = 4;
 Camera camera(vec3(0.0f, 0.0f, 0.0f));
 GLfloat deltaTime = 0.0f;
 GLfloat lastFrame = 0.0f;
@@ -253,6 +257,83 @@ GLuint loadTexture(char const * path)
 	return textureID;
 }
 
+#pragma region "Dynamic resolution"
+const GLuint scaleInterval = 8;				//ÿ֡һ
+const GLfloat scaleUpperBound = 1.05f;		//Ԥ5%Žͷֱ
+const GLfloat scaleLowerBound = 0.85f;		//Ԥ85%߷ֱʣ֮䲻
+const GLfloat maxScaleStep = 0.1f;
+const GLuint timerQueryCount = 4;			//ʱѯĽӳô֡ٶȡȴGPU
+const GLuint historySize = 16;
+
+GLfloat renderScale = maxRenderScale;
+GLuint renderWidth = screenWidth * maxRenderScale, renderHeight = screenHeight * maxRenderScale;
+GLfloat frameTimeHistory[historySize];
+GLuint historyIndex = 0, historyCount = 0;
+GLfloat frameTimeSum = 0.0f;
+GLuint frameTimeSamples = 0;
+GLuint skipSamples = 0;
+
+//¼һ֡GPUʱ䣬ÿscaleInterval֡ƽֵһţȾߴıʱtrue
+bool UpdateRenderScale(GLfloat gpuTime)
+{
+	frameTimeHistory[historyIndex] = gpuTime;
+	historyIndex = (historyIndex + 1) % historySize;
+	if (historyCount < historySize)
+	{
+		historyCount++;
+	}
+
+	//ոıߴļ֡Ǿɳߴµļʱ
+	if (skipSamples > 0)
+	{
+		skipSamples--;
+		return false;
+	}
+
+	frameTimeSum += gpuTime;
+	if (++frameTimeSamples < scaleInterval)
+	{
+		return false;
+	}
+	GLfloat average = frameTimeSum / frameTimeSamples;
+	frameTimeSum = 0.0f;
+	frameTimeSamples = 0;
+
+	if (average <= 0.0f || (average <= targetFrameTime * scaleUpperBound && average >= targetFrameTime * scaleLowerBound))
+	{
+		return false;
+	}
+
+	//ŵƽȣ԰ʱֵƽĿȡ½м
+	GLfloat aimTime = targetFrameTime * (scaleUpperBound + scaleLowerBound) * 0.5f;
+	GLfloat newScale = renderScale * sqrt(aimTime / average);
+	newScale = glm::clamp(newScale, renderScale - maxScaleStep, renderScale + maxScaleStep);
+	newScale = glm::clamp(newScale, minRenderScale, maxRenderScale);
+
+	GLuint newWidth = glm::max(GLuint(screenWidth * newScale), 1u);
+	GLuint newHeight = glm::max(GLuint(screenHeight * newScale), 1u);
+	renderScale = newScale;
+	if (newWidth == renderWidth && newHeight == renderHeight)
+	{
+		return false;
+	}
+	renderWidth = newWidth;
+	renderHeight = newHeight;
+	skipSamples = timerQueryCount;
+	return true;
+}
+
+void PrintFrameStats()
+{
+	cout << "scale: " << renderScale << " (" << renderWidth << "x" << renderHeight << ")  gpu ms:";
+	for (GLuint i = 0; i < historyCount; i++)
+	{
+		cout << " " << frameTimeHistory[(historyIndex + historySize - historyCount + i) % historySize];
+	}
+	cout << endl;
+}
+#pragma endregion
+
 #pragma region "User input"
 bool keys[1024];
 bool keysPressed[1024];
@@ -330,7 +411,6 @@ int main()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
-	glfwWindowHint(GLFW_SAMPLES, 4);
 
 	GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "fuzhaodu", nullptr, nullptr);
 	glfwMakeContextCurrent(window);
@@ -572,13 +652,42 @@ int main()
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 
-	glm::mat4 projection = perspective(camera.Zoom, (float)screenWidth / (float)screenHeight, 0.1f, 100.0f);
-	pbrShader.Use();
-	glUniformMatrix4fv(glGetUniformLocation(pbrShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-	backgroundShader.Use();
-	glUniformMatrix4fv(glGetUniformLocation(backgroundShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	//ֱ̬:ȻŷĶز֡Уֻʹ½renderWidth x renderHeight
+	GLuint sceneWidth = screenWidth * maxRenderScale;
+	GLuint sceneHeight = screenHeight * maxRenderScale;
+	GLuint sceneFBO;
+	GLuint sceneColorRBO, sceneDepthRBO;
+	glGenFramebuffers(1, &sceneFBO);
+	glGenRenderbuffers(1, &sceneColorRBO);
+	glGenRenderbuffers(1, &sceneDepthRBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, sceneColorRBO);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples, GL_RGBA8, sceneWidth, sceneHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, sceneColorRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, sceneDepthRBO);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples, GL_DEPTH_COMPONENT24, sceneWidth, sceneHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRBO);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Scene framebuffer is not complete." << std::endl;
+	}
+
+	//ֱ̬:زͨ֡壬ԷŴ󵽴ڣʼȾߴһ£Թ˲Ų֡
+	GLuint resolveFBO;
+	GLuint resolveColorRBO;
+	glGenFramebuffers(1, &resolveFBO);
+	glGenRenderbuffers(1, &resolveColorRBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, resolveColorRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, renderWidth, renderHeight);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveColorRBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	glViewport(0, 0, screenWidth, screenHeight);
+	GLuint timerQueries[timerQueryCount];
+	bool queryPending[timerQueryCount] = {};
+	glGenQueries(timerQueryCount, timerQueries);
+	GLuint frameIndex = 0;
+	GLfloat lastStatsTime = glfwGetTime();
 
 	while (!glfwWindowShouldClose(window))
 	{
@@ -589,6 +698,48 @@ int main()
 		glfwPollEvents();
 		Do_Movement();
 
+		//ֱ̬:ȡtimerQueryCount֮֡ǰGPUʱݽȾߴ磻ûһ֡ҲټʱȴGPU
+		GLuint queryIndex = frameIndex % timerQueryCount;
+		GLuint query = timerQueries[queryIndex];
+		bool queryFree = true;
+		if (queryPending[queryIndex])
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available)
+			{
+				GLuint64 elapsed;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+				queryPending[queryIndex] = false;
+				if (UpdateRenderScale(elapsed / 1000000.0f))
+				{
+					glBindRenderbuffer(GL_RENDERBUFFER, resolveColorRBO);
+					glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, renderWidth, renderHeight);
+				}
+			}
+			else
+			{
+				queryFree = false;
+			}
+		}
+		if (currentFrame - lastStatsTime >= 1.0f)
+		{
+			PrintFrameStats();
+			lastStatsTime = currentFrame;
+		}
+		if (queryFree)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, query);
+		}
+
+		glm::mat4 projection = perspective(camera.Zoom, (float)renderWidth / (float)renderHeight, 0.1f, 100.0f);
+		pbrShader.Use();
+		glUniformMatrix4fv(glGetUniformLocation(pbrShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+		backgroundShader.Use();
+		glUniformMatrix4fv(glGetUniformLocation(backgroundShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+		glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+		glViewport(0, 0, renderWidth, renderHeight);
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -649,9 +800,25 @@ int main()
 		//brdfShader.Use();
 		//RenderQuad();
 
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+		glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, renderWidth, renderHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if (queryFree)
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			queryPending[queryIndex] = true;
+		}
+		frameIndex++;
+
 		glfwSwapBuffers(window);
 	}
 
+	glDeleteQueries(timerQueryCount, timerQueries);
 	glfwTerminate();
 	return 0;
 }
\ No newline at end of file